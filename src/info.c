@@ -2,8 +2,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/resource.h>
 #include <sys/utsname.h>
 #include <sys/statvfs.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 #ifdef HAVE_LIBCPUID
 #include <libcpuid/libcpuid.h>
@@ -546,6 +556,1151 @@ char* get_gpu_info() {
     return result;
 }
 
+// ------------------------
+// Live GPU metrics
+// ------------------------
+
+#define DRM_MAX_CARDS 8
+#define DRM_MAX_ENGINES 16
+#define DRM_TOP_CLIENTS 3
+#define DRM_RESCAN_SLICES 30
+#define MAX_REPORT_LENGTH 4096
+#define DRM_PMU_PATH "/sys/bus/event_source/devices"
+
+struct drm_engine {
+    char name[24];
+    unsigned long long busy;   // ns, or cycles on xe
+    unsigned long long total;  // total cycles on xe, 0 for ns counters
+    double usage;
+};
+
+struct drm_client {
+    int fd;
+    int samples;
+    unsigned long long id;
+    char driver[32];
+    char pdev[32];
+    int nengines;
+    struct drm_engine engines[DRM_MAX_ENGINES];
+    long long mem_bytes;
+    double usage;
+};
+
+// One entry per pid; pids without DRM fds are kept too so they are not rescanned
+struct drm_proc {
+    pid_t pid;
+    char comm[32];
+    int nclients;
+    struct drm_client* clients;
+};
+
+// Device-wide engine busy counters from the i915 perf PMU
+struct drm_pmu {
+    char pdev[32];
+    int state;                 // 0 not tried yet, 1 counting, -1 unavailable
+    int nevents;
+    int fds[DRM_MAX_ENGINES];
+    unsigned long long prev[DRM_MAX_ENGINES];
+    struct timespec prev_time;
+    int sampled;
+};
+
+struct drm_card {
+    char name[16];
+    char driver[32];
+    char pdev[32];
+    int busy_percent;
+    int busy_from_pmu;         // PMU counters are open, even before the first delta
+    int has_render_node;
+    long long vram_used;
+    long long vram_total;
+    int nengines;
+    struct drm_engine engines[DRM_MAX_ENGINES];
+};
+
+static pthread_mutex_t drm_lock = PTHREAD_MUTEX_INITIALIZER;
+static DIR* drm_proc_dir = NULL;
+static struct drm_proc* drm_procs = NULL;
+static int drm_nprocs = 0;
+static struct drm_pmu drm_pmus[DRM_MAX_CARDS];
+static unsigned long drm_tick = 0;
+static struct timespec drm_prev_time;
+
+// Cached /proc handle, rewound on every use. Each collector keeps its own
+// since they may run on different threads.
+static DIR* get_proc_dir(DIR** dir) {
+    if (!*dir) {
+        *dir = opendir("/proc");
+    } else {
+        rewinddir(*dir);
+    }
+    return *dir;
+}
+
+// Read a small file relative to dirfd, returns its length or -1
+static ssize_t read_file_at(int dirfd, const char* path, char* buf, size_t size) {
+    int fd = openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    ssize_t total = 0;
+    while ((size_t)total < size - 1) {
+        ssize_t n = read(fd, buf + total, size - 1 - total);
+        if (n <= 0) break;
+        total += n;
+    }
+
+    close(fd);
+    buf[total] = '\0';
+    return total;
+}
+
+static int read_ll_at(int dirfd, const char* path, long long* value) {
+    char buf[64];
+    if (read_file_at(dirfd, path, buf, sizeof(buf)) <= 0) return 0;
+
+    char* end;
+    *value = strtoll(buf, &end, 10);
+    return end != buf;
+}
+
+// Parse a non-negative decimal name such as a pid or fd, -1 otherwise
+static int parse_number(const char* name) {
+    if (!*name) return -1;
+
+    long value = 0;
+    for (const char* p = name; *p; p++) {
+        if (!isdigit((unsigned char)*p)) return -1;
+        value = value * 10 + (*p - '0');
+        if (value > INT_MAX) return -1;
+    }
+    return (int)value;
+}
+
+static void format_size(long long bytes, char* buf, size_t size) {
+    if (bytes >= 1024LL * 1024 * 1024) {
+        snprintf(buf, size, "%.1f GB", (double)bytes / (1024.0 * 1024 * 1024));
+    } else {
+        snprintf(buf, size, "%.0f MB", (double)bytes / (1024.0 * 1024));
+    }
+}
+
+static int compare_drm_proc(const void* a, const void* b) {
+    pid_t pa = ((const struct drm_proc*)a)->pid;
+    pid_t pb = ((const struct drm_proc*)b)->pid;
+    return (pa > pb) - (pa < pb);
+}
+
+static struct drm_proc* find_drm_proc(pid_t pid) {
+    if (drm_nprocs == 0) return NULL;
+
+    struct drm_proc key = { .pid = pid };
+    return bsearch(&key, drm_procs, drm_nprocs, sizeof(struct drm_proc), compare_drm_proc);
+}
+
+static struct drm_engine* find_drm_engine(struct drm_engine* engines, int* count, const char* name) {
+    for (int i = 0; i < *count; i++) {
+        if (strcmp(engines[i].name, name) == 0) return &engines[i];
+    }
+    if (*count >= DRM_MAX_ENGINES) return NULL;
+
+    struct drm_engine* engine = &engines[(*count)++];
+    memset(engine, 0, sizeof(*engine));
+    snprintf(engine->name, sizeof(engine->name), "%s", name);
+    return engine;
+}
+
+// Memory keys are "<n>", "<n> KiB" or "<n> MiB"
+static long long parse_drm_size(const char* value) {
+    char* unit;
+    long long size = strtoll(value, &unit, 10);
+    while (*unit == ' ' || *unit == '\t') unit++;
+
+    if (strncmp(unit, "KiB", 3) == 0) {
+        size *= 1024;
+    } else if (strncmp(unit, "MiB", 3) == 0) {
+        size *= 1024 * 1024;
+    } else if (strncmp(unit, "GiB", 3) == 0) {
+        size *= 1024LL * 1024 * 1024;
+    }
+    return size;
+}
+
+// Collect the /dev/dri descriptors of a process, keeping samples from the previous table
+static void scan_drm_fds(int proc_fd, const struct drm_proc* old, struct drm_proc* entry) {
+    char path[64];
+    snprintf(path, sizeof(path), "%d/fd", entry->pid);
+
+    int fd_dir = openat(proc_fd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd_dir < 0) return;
+
+    DIR* dir = fdopendir(fd_dir);
+    if (!dir) {
+        close(fd_dir);
+        return;
+    }
+
+    struct dirent* de;
+    while ((de = readdir(dir))) {
+        int fd = parse_number(de->d_name);
+        if (fd < 0) continue;
+
+        char target[64];
+        ssize_t len = readlinkat(dirfd(dir), de->d_name, target, sizeof(target) - 1);
+        if (len <= 0) continue;
+        target[len] = '\0';
+        if (strncmp(target, "/dev/dri/", 9) != 0) continue;
+
+        struct drm_client* clients = realloc(entry->clients, (entry->nclients + 1) * sizeof(struct drm_client));
+        if (!clients) break;
+        entry->clients = clients;
+
+        struct drm_client* client = &clients[entry->nclients++];
+        memset(client, 0, sizeof(*client));
+        client->fd = fd;
+
+        for (int i = 0; old && i < old->nclients; i++) {
+            if (old->clients[i].fd == fd) {
+                *client = old->clients[i];
+                break;
+            }
+        }
+    }
+    closedir(dir);
+
+    if (entry->nclients > 0) {
+        snprintf(path, sizeof(path), "%d/comm", entry->pid);
+        if (read_file_at(proc_fd, path, entry->comm, sizeof(entry->comm)) > 0) {
+            char* newline = strchr(entry->comm, '\n');
+            if (newline) *newline = '\0';
+        }
+    }
+}
+
+// Re-read one fdinfo entry; returns 0 once the descriptor is no longer a DRM client
+static int update_drm_client(int proc_fd, pid_t pid, struct drm_client* client, double elapsed_ns) {
+    char path[64];
+    char buf[4096];
+    snprintf(path, sizeof(path), "%d/fdinfo/%d", pid, client->fd);
+    if (read_file_at(proc_fd, path, buf, sizeof(buf)) <= 0) return 0;
+
+    struct drm_engine engines[DRM_MAX_ENGINES];
+    int nengines = 0;
+    int has_resident = 0;
+    long long resident = 0, memory = 0;
+    unsigned long long id = 0;
+    char driver[32] = "";
+    char pdev[32] = "";
+
+    char* save = NULL;
+    for (char* line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        char* value = strchr(line, ':');
+        if (!value) continue;
+        *value++ = '\0';
+        while (*value == ' ' || *value == '\t') value++;
+
+        struct drm_engine* engine = NULL;
+        if (strcmp(line, "drm-driver") == 0) {
+            snprintf(driver, sizeof(driver), "%s", value);
+        } else if (strcmp(line, "drm-pdev") == 0) {
+            snprintf(pdev, sizeof(pdev), "%s", value);
+        } else if (strcmp(line, "drm-client-id") == 0) {
+            id = strtoull(value, NULL, 10);
+        } else if (strncmp(line, "drm-engine-capacity-", 20) == 0) {
+            continue;
+        } else if (strncmp(line, "drm-engine-", 11) == 0) {
+            engine = find_drm_engine(engines, &nengines, line + 11);
+            if (engine) engine->busy = strtoull(value, NULL, 10);
+        } else if (strncmp(line, "drm-total-cycles-", 17) == 0) {
+            engine = find_drm_engine(engines, &nengines, line + 17);
+            if (engine) engine->total = strtoull(value, NULL, 10);
+        } else if (strncmp(line, "drm-cycles-", 11) == 0) {
+            engine = find_drm_engine(engines, &nengines, line + 11);
+            if (engine) engine->busy = strtoull(value, NULL, 10);
+        } else if (strncmp(line, "drm-resident-", 13) == 0) {
+            resident += parse_drm_size(value);
+            has_resident = 1;
+        } else if (strncmp(line, "drm-memory-", 11) == 0) {
+            memory += parse_drm_size(value);
+        }
+    }
+
+    if (!driver[0]) return 0;
+
+    // The fd number may have been reused for another client
+    int has_prev = client->samples > 0 && client->id == id && elapsed_ns > 0;
+    client->usage = 0;
+
+    for (int i = 0; i < nengines; i++) {
+        struct drm_engine* engine = &engines[i];
+        engine->usage = 0;
+        if (!has_prev) continue;
+
+        struct drm_engine* prev = NULL;
+        for (int j = 0; j < client->nengines; j++) {
+            if (strcmp(client->engines[j].name, engine->name) == 0) {
+                prev = &client->engines[j];
+                break;
+            }
+        }
+        if (!prev || engine->busy < prev->busy) continue;
+
+        double busy = (double)(engine->busy - prev->busy);
+        if (engine->total > 0) {
+            if (engine->total > prev->total) {
+                engine->usage = busy / (double)(engine->total - prev->total) * 100.0;
+            }
+        } else {
+            engine->usage = busy / elapsed_ns * 100.0;
+        }
+
+        if (engine->usage > 100.0) engine->usage = 100.0;
+        if (engine->usage > client->usage) client->usage = engine->usage;
+    }
+
+    memcpy(client->engines, engines, nengines * sizeof(struct drm_engine));
+    client->nengines = nengines;
+    client->id = id;
+    client->mem_bytes = has_resident ? resident : memory;
+    strcpy(client->driver, driver);
+    strcpy(client->pdev, pdev);
+    client->samples = has_prev ? client->samples + 1 : 1;
+    return 1;
+}
+
+// Incremental /proc walk: only pids not seen on the previous tick get their fd
+// table scanned. To pick up processes that open a render node later on, one
+// DRM_RESCAN_SLICES-th of the known pids (by pid modulo) is rescanned per tick,
+// so no single tick walks every fd in the system.
+static void update_drm_clients(double elapsed_ns) {
+    DIR* dir = get_proc_dir(&drm_proc_dir);
+    if (!dir) return;
+
+    int proc_fd = dirfd(dir);
+    int slice = drm_tick % DRM_RESCAN_SLICES;
+
+    struct drm_proc* procs = NULL;
+    int nprocs = 0, capacity = 0;
+
+    struct dirent* de;
+    while ((de = readdir(dir))) {
+        int pid = parse_number(de->d_name);
+        if (pid <= 0) continue;
+
+        if (nprocs == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 1024;
+            struct drm_proc* new_procs = realloc(procs, new_capacity * sizeof(struct drm_proc));
+            if (!new_procs) break;
+            procs = new_procs;
+            capacity = new_capacity;
+        }
+
+        struct drm_proc* entry = &procs[nprocs++];
+        struct drm_proc* old = find_drm_proc(pid);
+
+        if (old && pid % DRM_RESCAN_SLICES != slice) {
+            *entry = *old;
+            old->clients = NULL;
+            old->nclients = 0;
+        } else {
+            memset(entry, 0, sizeof(*entry));
+            entry->pid = pid;
+            scan_drm_fds(proc_fd, old, entry);
+        }
+    }
+
+    for (int i = 0; i < drm_nprocs; i++) {
+        free(drm_procs[i].clients);
+    }
+    free(drm_procs);
+
+    qsort(procs, nprocs, sizeof(struct drm_proc), compare_drm_proc);
+    drm_procs = procs;
+    drm_nprocs = nprocs;
+
+    for (int i = 0; i < drm_nprocs; i++) {
+        struct drm_proc* proc = &drm_procs[i];
+        for (int j = 0; j < proc->nclients; j++) {
+            if (!update_drm_client(proc_fd, proc->pid, &proc->clients[j], elapsed_ns)) {
+                proc->clients[j--] = proc->clients[--proc->nclients];
+            }
+        }
+    }
+}
+
+static int compare_drm_card(const void* a, const void* b) {
+    const struct drm_card* ca = a;
+    const struct drm_card* cb = b;
+    return atoi(ca->name + 4) - atoi(cb->name + 4);
+}
+
+// Resolve a sysfs symlink relative to dirfd and return its last component
+static void read_link_basename(int dirfd, const char* path, char* buf, size_t size) {
+    char target[PATH_MAX];
+    ssize_t len = readlinkat(dirfd, path, target, sizeof(target) - 1);
+    if (len <= 0) return;
+    target[len] = '\0';
+
+    char* base = strrchr(target, '/');
+    snprintf(buf, size, "%.*s", (int)size - 1, base ? base + 1 : target);
+}
+
+static int read_drm_cards(struct drm_card* cards, int max) {
+    DIR* dir = opendir("/sys/class/drm");
+    if (!dir) return 0;
+
+    int count = 0;
+    struct dirent* de;
+    while ((de = readdir(dir)) && count < max) {
+        // Skip connectors such as card0-DP-1
+        if (strncmp(de->d_name, "card", 4) != 0 || parse_number(de->d_name + 4) < 0) continue;
+
+        struct drm_card* card = &cards[count];
+        memset(card, 0, sizeof(*card));
+        snprintf(card->name, sizeof(card->name), "%.*s", (int)sizeof(card->name) - 1, de->d_name);
+        card->busy_percent = -1;
+        card->vram_used = -1;
+        card->vram_total = -1;
+
+        char path[PATH_MAX];
+        snprintf(path, sizeof(path), "%s/device", de->d_name);
+        int device_fd = openat(dirfd(dir), path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (device_fd < 0) continue;
+
+        read_link_basename(dirfd(dir), path, card->pdev, sizeof(card->pdev));
+        read_link_basename(device_fd, "driver", card->driver, sizeof(card->driver));
+
+        // amdgpu exposes these directly; i915 and xe are derived from fdinfo instead
+        long long value;
+        if (read_ll_at(device_fd, "gpu_busy_percent", &value)) card->busy_percent = (int)value;
+        if (read_ll_at(device_fd, "mem_info_vram_used", &value)) card->vram_used = value;
+        if (read_ll_at(device_fd, "mem_info_vram_total", &value)) card->vram_total = value;
+
+        // Display-only KMS devices have no render node and no engines to report
+        int drm_fd = openat(device_fd, "drm", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        DIR* drm_dir = drm_fd >= 0 ? fdopendir(drm_fd) : NULL;
+        if (drm_dir) {
+            struct dirent* node;
+            while ((node = readdir(drm_dir))) {
+                if (strncmp(node->d_name, "renderD", 7) == 0) card->has_render_node = 1;
+            }
+            closedir(drm_dir);
+        } else if (drm_fd >= 0) {
+            close(drm_fd);
+        }
+
+        close(device_fd);
+        count++;
+    }
+
+    closedir(dir);
+    qsort(cards, count, sizeof(struct drm_card), compare_drm_card);
+    return count;
+}
+
+static int open_drm_pmu_dir(const struct drm_card* card) {
+    // Discrete cards get an i915_<pci address> PMU, integrated ones plain i915
+    char name[PATH_MAX];
+    snprintf(name, sizeof(name), "%s/i915_%s", DRM_PMU_PATH, card->pdev);
+    for (char* p = name + strlen(DRM_PMU_PATH) + 1; *p; p++) {
+        if (*p == ':') *p = '_';
+    }
+
+    int fd = open(name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) fd = open(DRM_PMU_PATH "/i915", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return fd;
+}
+
+// Open one counter per "<engine>-busy" event; any failure (usually
+// perf_event_paranoid without CAP_PERFMON) leaves the fdinfo fallback
+static int open_drm_pmu(const struct drm_card* card, struct drm_pmu* pmu) {
+    int pmu_fd = open_drm_pmu_dir(card);
+    if (pmu_fd < 0) return 0;
+
+    long long type, cpu = 0;
+    if (!read_ll_at(pmu_fd, "type", &type)) {
+        close(pmu_fd);
+        return 0;
+    }
+    read_ll_at(pmu_fd, "cpumask", &cpu);
+
+    int events_fd = openat(pmu_fd, "events", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    close(pmu_fd);
+    DIR* dir = events_fd >= 0 ? fdopendir(events_fd) : NULL;
+    if (!dir) {
+        if (events_fd >= 0) close(events_fd);
+        return 0;
+    }
+
+    struct dirent* de;
+    while ((de = readdir(dir)) && pmu->nevents < DRM_MAX_ENGINES) {
+        size_t len = strlen(de->d_name);
+        if (len < 5 || strcmp(de->d_name + len - 5, "-busy") != 0) continue;
+
+        char buf[128];
+        if (read_file_at(dirfd(dir), de->d_name, buf, sizeof(buf)) <= 0) continue;
+        char* config = strstr(buf, "config=");
+        if (!config) continue;
+
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = (unsigned int)type;
+        attr.size = sizeof(attr);
+        attr.config = strtoull(config + 7, NULL, 0);
+
+        int fd = syscall(SYS_perf_event_open, &attr, -1, (int)cpu, -1, PERF_FLAG_FD_CLOEXEC);
+        if (fd < 0) {
+            for (int i = 0; i < pmu->nevents; i++) close(pmu->fds[i]);
+            pmu->nevents = 0;
+            break;
+        }
+        pmu->fds[pmu->nevents++] = fd;
+    }
+
+    closedir(dir);
+    return pmu->nevents > 0;
+}
+
+// Fill in busy_percent from the PMU; returns 0 when it is not available
+static int sample_drm_pmu(struct drm_card* card) {
+    struct drm_pmu* pmu = NULL;
+    for (int i = 0; i < DRM_MAX_CARDS; i++) {
+        if (drm_pmus[i].state != 0 && strcmp(drm_pmus[i].pdev, card->pdev) == 0) {
+            pmu = &drm_pmus[i];
+            break;
+        }
+        if (!pmu && drm_pmus[i].state == 0) pmu = &drm_pmus[i];
+    }
+    if (!pmu) return 0;
+
+    if (pmu->state == 0) {
+        snprintf(pmu->pdev, sizeof(pmu->pdev), "%s", card->pdev);
+        pmu->state = open_drm_pmu(card, pmu) ? 1 : -1;
+    }
+    if (pmu->state < 0) return 0;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed_ns = (now.tv_sec - pmu->prev_time.tv_sec) * 1e9 + (now.tv_nsec - pmu->prev_time.tv_nsec);
+
+    double busy = 0;
+    for (int i = 0; i < pmu->nevents; i++) {
+        unsigned long long value;
+        if (read(pmu->fds[i], &value, sizeof(value)) != sizeof(value)) continue;
+
+        if (pmu->sampled && value >= pmu->prev[i] && elapsed_ns > 0) {
+            double usage = (double)(value - pmu->prev[i]) / elapsed_ns * 100.0;
+            if (usage > busy) busy = usage;
+        }
+        pmu->prev[i] = value;
+    }
+
+    if (pmu->sampled) {
+        card->busy_percent = busy > 100.0 ? 100 : (int)(busy + 0.5);
+    }
+    card->busy_from_pmu = 1;
+    pmu->prev_time = now;
+    pmu->sampled = 1;
+    return 1;
+}
+
+// drm-pdev is only printed for PCI devices; platform GPUs such as panfrost,
+// msm or v3d are matched on the driver name instead
+static int drm_client_on_card(const struct drm_client* client, const struct drm_card* card) {
+    if (client->pdev[0]) return strcmp(client->pdev, card->pdev) == 0;
+    return strcmp(client->driver, card->driver) == 0;
+}
+
+struct drm_top {
+    pid_t pid;
+    const char* comm;
+    double usage;
+    long long mem_bytes;
+};
+
+// Append one card and its busiest clients to the report
+static void append_drm_card(struct drm_card* card, int sampled, char* report, size_t size) {
+    struct drm_top top[DRM_TOP_CLIENTS];
+    int ntop = 0;
+
+    int total_clients = 0;
+    for (int i = 0; i < drm_nprocs; i++) total_clients += drm_procs[i].nclients;
+    unsigned long long* seen = total_clients ? malloc(total_clients * sizeof(unsigned long long)) : NULL;
+    int nseen = 0;
+
+    for (int i = 0; i < drm_nprocs; i++) {
+        struct drm_proc* proc = &drm_procs[i];
+        struct drm_top entry = { proc->pid, proc->comm, 0, 0 };
+        int matched = 0;
+
+        for (int j = 0; j < proc->nclients; j++) {
+            struct drm_client* client = &proc->clients[j];
+            if (!drm_client_on_card(client, card)) continue;
+
+            // dup()ed and inherited descriptors share one client id
+            int duplicate = 0;
+            for (int k = 0; k < nseen; k++) {
+                if (seen[k] == client->id) {
+                    duplicate = 1;
+                    break;
+                }
+            }
+            if (duplicate) continue;
+            if (seen) seen[nseen++] = client->id;
+
+            matched = 1;
+            entry.usage += client->usage;
+            entry.mem_bytes += client->mem_bytes;
+
+            for (int e = 0; e < client->nengines; e++) {
+                struct drm_engine* engine = find_drm_engine(card->engines, &card->nengines, client->engines[e].name);
+                if (engine) engine->usage += client->engines[e].usage;
+            }
+        }
+
+        if (!matched || (entry.usage <= 0 && entry.mem_bytes <= 0)) continue;
+        if (entry.usage > 100.0) entry.usage = 100.0;
+
+        // Insert into the small top list, ordered by usage then memory
+        int pos = ntop;
+        while (pos > 0 && (top[pos - 1].usage < entry.usage ||
+               (top[pos - 1].usage == entry.usage && top[pos - 1].mem_bytes < entry.mem_bytes))) {
+            if (pos < DRM_TOP_CLIENTS) top[pos] = top[pos - 1];
+            pos--;
+        }
+        if (pos < DRM_TOP_CLIENTS) {
+            top[pos] = entry;
+            if (ntop < DRM_TOP_CLIENTS) ntop++;
+        }
+    }
+    free(seen);
+
+    // Without sysfs or PMU counters the busy figure is summed from fdinfo,
+    // which only covers clients this user may inspect
+    int from_fdinfo = card->busy_percent < 0 && !card->busy_from_pmu && card->has_render_node && sampled;
+    if (from_fdinfo) {
+        double busy = 0;
+        for (int e = 0; e < card->nengines; e++) {
+            if (card->engines[e].usage > busy) busy = card->engines[e].usage;
+        }
+        card->busy_percent = busy > 100.0 ? 100 : (int)(busy + 0.5);
+    }
+
+    size_t len = strlen(report);
+    if (len > 0) snprintf(report + len, size - len, "\n");
+
+    len = strlen(report);
+    snprintf(report + len, size - len, "%s", card->name);
+    if (card->driver[0]) {
+        len = strlen(report);
+        snprintf(report + len, size - len, " (%s)", card->driver);
+    }
+
+    const char* separator = ": ";
+    if (card->busy_percent >= 0) {
+        len = strlen(report);
+        snprintf(report + len, size - len, "%s%d%% busy%s", separator, card->busy_percent,
+                from_fdinfo ? " (visible clients only)" : "");
+        separator = ", ";
+    }
+    if (card->vram_used >= 0 && card->vram_total > 0) {
+        char used_str[64], total_str[64];
+        format_size(card->vram_used, used_str, sizeof(used_str));
+        format_size(card->vram_total, total_str, sizeof(total_str));
+        len = strlen(report);
+        snprintf(report + len, size - len, "%s%s / %s VRAM", separator, used_str, total_str);
+    }
+
+    for (int i = 0; i < ntop; i++) {
+        char mem_str[64];
+        format_size(top[i].mem_bytes, mem_str, sizeof(mem_str));
+        len = strlen(report);
+        if (sampled) {
+            snprintf(report + len, size - len, "\n    %s (%d): %.0f%%, %s",
+                    top[i].comm, top[i].pid, top[i].usage, mem_str);
+        } else {
+            snprintf(report + len, size - len, "\n    %s (%d): %s",
+                    top[i].comm, top[i].pid, mem_str);
+        }
+    }
+}
+
+char* get_gpu_usage_info() {
+    struct drm_card cards[DRM_MAX_CARDS];
+    int ncards = read_drm_cards(cards, DRM_MAX_CARDS);
+    if (ncards == 0) return strdup("Unknown");
+
+    pthread_mutex_lock(&drm_lock);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed_ns = 0;
+    if (drm_tick > 0) {
+        elapsed_ns = (now.tv_sec - drm_prev_time.tv_sec) * 1e9 + (now.tv_nsec - drm_prev_time.tv_nsec);
+    }
+    drm_prev_time = now;
+
+    update_drm_clients(elapsed_ns);
+    drm_tick++;
+
+    char* result = malloc(MAX_REPORT_LENGTH);
+    if (!result) {
+        pthread_mutex_unlock(&drm_lock);
+        return strdup("Unknown");
+    }
+    result[0] = '\0';
+
+    for (int i = 0; i < ncards; i++) {
+        // xe has no fixed busy events to open, so it keeps the fdinfo cycles
+        if (cards[i].busy_percent < 0 && strcmp(cards[i].driver, "i915") == 0) {
+            sample_drm_pmu(&cards[i]);
+        }
+        append_drm_card(&cards[i], elapsed_ns > 0, result, MAX_REPORT_LENGTH);
+    }
+
+    pthread_mutex_unlock(&drm_lock);
+    return result;
+}
+
+// ------------------------
+// Top processes
+// ------------------------
+
+#define PROC_TOP_MAX 32
+#define PROC_CPU_MIN_INTERVAL 1.0
+#define PROC_FD_SHARE 4
+
+struct top_proc {
+    pid_t pid;
+    int stat_fd;
+    int statm_fd;
+    char comm[32];
+    unsigned long long start_time;  // tells a reused pid apart from the old process
+    unsigned long long cpu_ticks;
+    struct timespec cpu_time;  // when cpu_ticks was sampled
+    int cpu_sampled;
+    double cpu_percent;        // -1 until two samples exist
+    long long rss_bytes;
+    long long pss_bytes;       // -1 when smaps_rollup is not readable
+};
+
+static pthread_mutex_t top_lock = PTHREAD_MUTEX_INITIALIZER;
+static DIR* top_proc_dir = NULL;
+static struct top_proc* top_procs = NULL;
+static int top_nprocs = 0;
+static int top_cached_fds = 0;
+static int top_cached_by_cpu = -1;  // which ranking file the cached fds belong to
+static int top_cpu_swept = 0;
+static struct timespec top_cpu_sweep_time;  // end of the first CPU-mode sweep
+static long top_fd_budget = -1;
+
+static void close_top_proc(struct top_proc* proc) {
+    if (proc->stat_fd >= 0) {
+        close(proc->stat_fd);
+        top_cached_fds--;
+    }
+    if (proc->statm_fd >= 0) {
+        close(proc->statm_fd);
+        top_cached_fds--;
+    }
+}
+
+// Called once from main(): per-pid descriptors are kept open across ticks,
+// which needs more than the usual 1024 soft limit on busy hosts. GLib and
+// GTK poll() rather than select(), so high descriptor numbers are fine.
+void raise_fd_limit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Keep only a fixed share of the (raised) fd limit so GTK and the other
+// collectors keep enough
+static void init_top_fd_budget(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        top_fd_budget = 0;
+    } else if (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur > INT_MAX) {
+        top_fd_budget = INT_MAX / PROC_FD_SHARE;
+    } else {
+        top_fd_budget = (long)limit.rlim_cur / PROC_FD_SHARE;
+    }
+}
+
+static void close_top_fds(void) {
+    for (int i = 0; i < top_nprocs; i++) {
+        close_top_proc(&top_procs[i]);
+        top_procs[i].stat_fd = -1;
+        top_procs[i].statm_fd = -1;
+    }
+}
+
+// pread() a per-pid file through its cached descriptor, opening it on first
+// use. Files that are not cached, or over budget, are opened and closed on
+// every read instead.
+static ssize_t read_top_proc_file(int proc_fd, struct top_proc* proc, int* cached_fd, int cache,
+                                  const char* name, char* buf, size_t size) {
+    if (*cached_fd >= 0) {
+        ssize_t n = pread(*cached_fd, buf, size - 1, 0);
+        if (n > 0) {
+            buf[n] = '\0';
+            return n;
+        }
+
+        // Descriptors of an exited process keep failing even if the pid was
+        // reused, so start over with a fresh one and a fresh CPU baseline
+        close(*cached_fd);
+        *cached_fd = -1;
+        top_cached_fds--;
+        proc->cpu_sampled = 0;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "%d/%s", proc->pid, name);
+    int fd = openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    ssize_t n = pread(fd, buf, size - 1, 0);
+    if (n <= 0) {
+        close(fd);
+        return -1;
+    }
+    buf[n] = '\0';
+
+    if (cache && top_cached_fds < top_fd_budget) {
+        *cached_fd = fd;
+        top_cached_fds++;
+    } else {
+        close(fd);
+    }
+    return n;
+}
+
+static double seconds_between(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int read_top_proc_stat(int proc_fd, struct top_proc* proc, int cache,
+                              long clock_ticks, double max_cpu) {
+    char buf[1024];
+    if (read_top_proc_file(proc_fd, proc, &proc->stat_fd, cache, "stat", buf, sizeof(buf)) <= 0) return 0;
+
+    // comm may contain spaces and parentheses, so split on the last ')'
+    char* open = strchr(buf, '(');
+    char* close_paren = strrchr(buf, ')');
+    if (!open || !close_paren || close_paren < open) return 0;
+
+    size_t len = close_paren - open - 1;
+    if (len >= sizeof(proc->comm)) len = sizeof(proc->comm) - 1;
+    memcpy(proc->comm, open + 1, len);
+    proc->comm[len] = '\0';
+
+    unsigned long long utime, stime, start_time;
+    if (sscanf(close_paren + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu "
+               "%*d %*d %*d %*d %*d %*d %llu", &utime, &stime, &start_time) != 3) {
+        return 0;
+    }
+
+    // Uncached reads cannot notice a reused pid through a failing descriptor
+    if (proc->cpu_sampled && proc->start_time != start_time) proc->cpu_sampled = 0;
+    proc->start_time = start_time;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    unsigned long long ticks = utime + stime;
+
+    if (!proc->cpu_sampled || ticks < proc->cpu_ticks) {
+        proc->cpu_percent = -1;
+    } else {
+        // Times only advance in clock ticks, so a short interval gives wild
+        // figures; keep the old baseline and figure until enough time passed
+        double elapsed = seconds_between(&proc->cpu_time, &now);
+        if (elapsed < PROC_CPU_MIN_INTERVAL) return 1;
+
+        proc->cpu_percent = (double)(ticks - proc->cpu_ticks) / clock_ticks / elapsed * 100.0;
+        if (proc->cpu_percent > max_cpu) proc->cpu_percent = max_cpu;
+    }
+
+    proc->cpu_ticks = ticks;
+    proc->cpu_time = now;
+    proc->cpu_sampled = 1;
+    return 1;
+}
+
+static int read_top_proc_statm(int proc_fd, struct top_proc* proc, int cache, long page_size) {
+    char buf[256];
+    if (read_top_proc_file(proc_fd, proc, &proc->statm_fd, cache, "statm", buf, sizeof(buf)) <= 0) return 0;
+
+    unsigned long long size, resident;
+    if (sscanf(buf, "%llu %llu", &size, &resident) != 2) return 0;
+
+    proc->rss_bytes = (long long)resident * page_size;
+    return 1;
+}
+
+// PSS needs a page walk in the kernel, so it is only read for the few candidates
+static void read_top_proc_pss(int proc_fd, struct top_proc* proc) {
+    char path[64];
+    char buf[2048];
+    snprintf(path, sizeof(path), "%d/smaps_rollup", proc->pid);
+
+    proc->pss_bytes = -1;
+    if (read_file_at(proc_fd, path, buf, sizeof(buf)) <= 0) return;
+
+    char* pss = strstr(buf, "\nPss:");
+    long long pss_kb;
+    if (pss && sscanf(pss + 5, "%lld", &pss_kb) == 1) {
+        proc->pss_bytes = pss_kb * 1024;
+    }
+}
+
+static long long top_proc_memory(const struct top_proc* proc) {
+    return proc->pss_bytes >= 0 ? proc->pss_bytes : proc->rss_bytes;
+}
+
+static int top_proc_less(const struct top_proc* a, const struct top_proc* b, int by_cpu, int by_pss) {
+    if (by_cpu) {
+        if (a->cpu_percent != b->cpu_percent) return a->cpu_percent < b->cpu_percent;
+        return a->rss_bytes < b->rss_bytes;
+    }
+    long long ma = by_pss ? top_proc_memory(a) : a->rss_bytes;
+    long long mb = by_pss ? top_proc_memory(b) : b->rss_bytes;
+    if (ma != mb) return ma < mb;
+    return a->cpu_percent < b->cpu_percent;
+}
+
+static void top_heap_sift_down(struct top_proc** heap, int count, struct top_proc* proc,
+                               int by_cpu, int by_pss) {
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= count) break;
+        if (child + 1 < count && top_proc_less(heap[child + 1], heap[child], by_cpu, by_pss)) child++;
+        if (!top_proc_less(heap[child], proc, by_cpu, by_pss)) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = proc;
+}
+
+// Bounded min-heap: keeps the largest `capacity` entries seen so far
+static void top_heap_push(struct top_proc** heap, int* count, int capacity,
+                          struct top_proc* proc, int by_cpu, int by_pss) {
+    if (*count < capacity) {
+        int i = (*count)++;
+        while (i > 0 && top_proc_less(proc, heap[(i - 1) / 2], by_cpu, by_pss)) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = proc;
+    } else if (capacity > 0 && top_proc_less(heap[0], proc, by_cpu, by_pss)) {
+        top_heap_sift_down(heap, *count, proc, by_cpu, by_pss);
+    }
+}
+
+static struct top_proc* top_heap_pop(struct top_proc** heap, int* count, int by_cpu, int by_pss) {
+    struct top_proc* smallest = heap[0];
+    struct top_proc* last = heap[--(*count)];
+    if (*count > 0) top_heap_sift_down(heap, *count, last, by_cpu, by_pss);
+    return smallest;
+}
+
+static int compare_top_proc(const void* a, const void* b) {
+    pid_t pa = ((const struct top_proc*)a)->pid;
+    pid_t pb = ((const struct top_proc*)b)->pid;
+    return (pa > pb) - (pa < pb);
+}
+
+static struct top_proc* find_top_proc(pid_t pid) {
+    if (top_nprocs == 0) return NULL;
+
+    struct top_proc key = { .pid = pid };
+    return bsearch(&key, top_procs, top_nprocs, sizeof(struct top_proc), compare_top_proc);
+}
+
+// Rebuild the pid table from /proc, carrying over cached descriptors and CPU baselines
+static int update_top_procs(void) {
+    DIR* dir = get_proc_dir(&top_proc_dir);
+    if (!dir) return -1;
+
+    struct top_proc* procs = NULL;
+    int nprocs = 0, capacity = 0;
+
+    struct dirent* de;
+    while ((de = readdir(dir))) {
+        int pid = parse_number(de->d_name);
+        if (pid <= 0) continue;
+
+        if (nprocs == capacity) {
+            int new_capacity = capacity ? capacity * 2 : 1024;
+            struct top_proc* new_procs = realloc(procs, new_capacity * sizeof(struct top_proc));
+            if (!new_procs) break;
+            procs = new_procs;
+            capacity = new_capacity;
+        }
+
+        struct top_proc* entry = &procs[nprocs++];
+        struct top_proc* old = find_top_proc(pid);
+
+        if (old) {
+            *entry = *old;
+            old->stat_fd = -1;
+            old->statm_fd = -1;
+        } else {
+            memset(entry, 0, sizeof(*entry));
+            entry->pid = pid;
+            entry->stat_fd = -1;
+            entry->statm_fd = -1;
+            entry->cpu_percent = -1;
+        }
+        entry->pss_bytes = -1;
+    }
+
+    for (int i = 0; i < top_nprocs; i++) {
+        close_top_proc(&top_procs[i]);
+    }
+    free(top_procs);
+
+    qsort(procs, nprocs, sizeof(struct top_proc), compare_top_proc);
+    top_procs = procs;
+    top_nprocs = nprocs;
+    return dirfd(dir);
+}
+
+// Returns NULL while a CPU ranking is still sampling its baseline
+char* get_top_processes_info(int count, int by_cpu) {
+    if (count < 1) count = 1;
+    if (count > PROC_TOP_MAX) count = PROC_TOP_MAX;
+
+    pthread_mutex_lock(&top_lock);
+
+    // Memory mode only samples CPU time for its candidates, so a CPU ranking
+    // needs one sweep over every pid and PROC_CPU_MIN_INTERVAL after it
+    // before the figures can be compared
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int ranked = !by_cpu ||
+                 (top_cpu_swept && seconds_between(&top_cpu_sweep_time, &start) >= PROC_CPU_MIN_INTERVAL);
+
+    if (top_fd_budget < 0) init_top_fd_budget();
+
+    int proc_fd = update_top_procs();
+    if (proc_fd < 0) {
+        pthread_mutex_unlock(&top_lock);
+        return strdup("Unknown");
+    }
+
+    // Only the ranking file is worth keeping open; drop the other kind
+    if (top_cached_by_cpu != by_cpu) {
+        close_top_fds();
+        top_cached_by_cpu = by_cpu;
+    }
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    long clock_ticks = sysconf(_SC_CLK_TCK);
+    if (clock_ticks <= 0) clock_ticks = 100;
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    double max_cpu = (ncpus > 0 ? ncpus : 1) * 100.0;
+
+    // Only the ranking file is read for every pid; the other one is read for
+    // the candidates. Memory ranking preselects by RSS, then ranks by PSS.
+    struct top_proc* candidates[PROC_TOP_MAX * 2];
+    int ncandidates = 0;
+    int capacity = by_cpu ? count : count * 2;
+
+    for (int i = 0; i < top_nprocs; i++) {
+        struct top_proc* proc = &top_procs[i];
+        int sampled = by_cpu ? read_top_proc_stat(proc_fd, proc, 1, clock_ticks, max_cpu)
+                             : read_top_proc_statm(proc_fd, proc, 1, page_size);
+        if (sampled && ranked) {
+            top_heap_push(candidates, &ncandidates, capacity, proc, by_cpu, 0);
+        }
+    }
+
+    if (!by_cpu) {
+        top_cpu_swept = 0;
+    } else if (!top_cpu_swept) {
+        top_cpu_swept = 1;
+        clock_gettime(CLOCK_MONOTONIC, &top_cpu_sweep_time);
+    }
+
+    if (!ranked) {
+        pthread_mutex_unlock(&top_lock);
+        return NULL;
+    }
+
+    struct top_proc* top[PROC_TOP_MAX];
+    int ntop = 0;
+
+    for (int i = 0; i < ncandidates; i++) {
+        struct top_proc* proc = candidates[i];
+        if (by_cpu) {
+            read_top_proc_statm(proc_fd, proc, 0, page_size);
+        } else {
+            read_top_proc_stat(proc_fd, proc, 0, clock_ticks, max_cpu);
+        }
+        read_top_proc_pss(proc_fd, proc);
+        top_heap_push(top, &ntop, count, proc, by_cpu, 1);
+    }
+
+    // Popping the min-heap yields ascending order
+    struct top_proc* sorted[PROC_TOP_MAX];
+    int nsorted = ntop;
+    for (int i = nsorted - 1; i >= 0; i--) {
+        sorted[i] = top_heap_pop(top, &ntop, by_cpu, 1);
+    }
+
+    char* result = malloc(MAX_REPORT_LENGTH);
+    if (!result) {
+        pthread_mutex_unlock(&top_lock);
+        return strdup("Unknown");
+    }
+    result[0] = '\0';
+
+    for (int i = 0; i < nsorted; i++) {
+        struct top_proc* proc = sorted[i];
+        char mem_str[64];
+        format_size(top_proc_memory(proc), mem_str, sizeof(mem_str));
+
+        size_t len = strlen(result);
+        snprintf(result + len, MAX_REPORT_LENGTH - len, "%s%s (%d): %s %s",
+                i > 0 ? "\n" : "", proc->comm, proc->pid, mem_str,
+                proc->pss_bytes >= 0 ? "PSS" : "RSS");
+        if (proc->cpu_percent >= 0) {
+            len = strlen(result);
+            snprintf(result + len, MAX_REPORT_LENGTH - len, ", %.0f%% CPU", proc->cpu_percent);
+        }
+    }
+
+    pthread_mutex_unlock(&top_lock);
+
+    if (nsorted == 0) {
+        free(result);
+        return strdup("Unknown");
+    }
+    return result;
+}
+
+// Drop the pid table, its cached descriptors and the /proc handle
+void release_top_processes() {
+    pthread_mutex_lock(&top_lock);
+
+    close_top_fds();
+    free(top_procs);
+    top_procs = NULL;
+    top_nprocs = 0;
+    top_cached_by_cpu = -1;
+    top_cpu_swept = 0;
+
+    if (top_proc_dir) {
+        closedir(top_proc_dir);
+        top_proc_dir = NULL;
+    }
+
+    pthread_mutex_unlock(&top_lock);
+}
+
 char* get_uptime_info() {
     char* uptime_str = read_file("/proc/uptime");
     if (!uptime_str) {
@@ -7,7 +7,11 @@ char* get_os_info();
 char* get_kernel_info();
 char* get_cpu_detailed_info(); 
 char* get_memory_info();
+char* get_top_processes_info(int count, int by_cpu);
+void release_top_processes();
+void raise_fd_limit();
 char* get_gpu_info();
+char* get_gpu_usage_info();
 char* get_uptime_info();
 char* get_storage_info();
 char* get_serial_number();
@@ -9,7 +9,11 @@ extern string get_os_info();
 extern string get_kernel_info();
 extern string get_cpu_detailed_info();
 extern string get_memory_info();
+extern string? get_top_processes_info(int count, bool by_cpu);
+extern void release_top_processes();
+extern void raise_fd_limit();
 extern string get_gpu_info();
+extern string get_gpu_usage_info();
 extern string get_display_info();
 extern string get_uptime_info();
 extern string get_storage_info();
@@ -37,6 +41,14 @@ public class ATSApplication : Adw.Application {
     private Gtk.Box main_content;
     private Gtk.Box info_container;
     private Gtk.Image logo_image;
+    private Gtk.Label gpu_usage_label;
+    private bool gpu_usage_busy = false;
+    private Gtk.Expander top_processes_expander;
+    private Gtk.Label top_processes_label;
+    private bool top_processes_by_cpu = false;
+    private bool top_processes_busy = false;
+
+    private const int TOP_PROCESSES = 10;
 
     private static string? forced_distro = null;
 
@@ -245,9 +257,12 @@ public class ATSApplication : Adw.Application {
         create_info_row(_("Processor"), get_cpu_detailed_info());
         add_separator();
         create_info_row(_("Memory"), get_memory_info());
+        create_top_processes_section();
         add_separator();
         create_info_row(_("Graphics"), get_gpu_info());
         add_separator();
+        gpu_usage_label = create_info_row(_("GPU Usage"), "");
+        add_separator();
         create_info_row(_("Display"), get_display_info());
         add_separator();
         create_info_row(_("Uptime"), get_uptime_info());
@@ -259,9 +274,122 @@ public class ATSApplication : Adw.Application {
             add_separator();
             create_info_row(_("Serial Number"), serial);
         }
+
+        // Busy percentages are deltas between samples, so keep polling
+        refresh_gpu_usage();
+        Timeout.add_seconds(2, () => {
+            refresh_gpu_usage();
+            if (top_processes_expander.get_expanded()) {
+                refresh_top_processes();
+            }
+            return Source.CONTINUE;
+        });
     }
 
-    private void create_info_row(string label, string value) {
+    // The fdinfo scan walks /proc as well, so it gets the same treatment as
+    // the top processes view below
+    private void refresh_gpu_usage() {
+        if (gpu_usage_busy) return;
+        gpu_usage_busy = true;
+
+        new Thread<void*>("ats-gpu-usage", () => {
+            string report = get_gpu_usage_info();
+            Idle.add(() => {
+                gpu_usage_label.set_label(report);
+                gpu_usage_busy = false;
+                return Source.REMOVE;
+            });
+            return null;
+        });
+    }
+
+    private void create_top_processes_section() {
+        var memory_toggle = new Gtk.ToggleButton.with_label(_("Memory"));
+        memory_toggle.set_active(true);
+
+        var cpu_toggle = new Gtk.ToggleButton.with_label(_("CPU"));
+        cpu_toggle.set_group(memory_toggle);
+        cpu_toggle.toggled.connect(() => {
+            top_processes_by_cpu = cpu_toggle.get_active();
+            refresh_top_processes();
+        });
+
+        var sort_box = new Gtk.Box(Gtk.Orientation.HORIZONTAL, 0);
+        sort_box.add_css_class("linked");
+        sort_box.set_halign(Gtk.Align.START);
+        sort_box.append(memory_toggle);
+        sort_box.append(cpu_toggle);
+
+        top_processes_label = new Gtk.Label(null);
+        top_processes_label.set_xalign(0);
+        top_processes_label.set_wrap(true);
+        top_processes_label.set_wrap_mode(Pango.WrapMode.WORD_CHAR);
+        top_processes_label.set_selectable(true);
+        top_processes_label.add_css_class("body");
+        top_processes_label.opacity = 0.5;
+
+        var content = new Gtk.Box(Gtk.Orientation.VERTICAL, 8);
+        content.set_margin_top(8);
+        content.set_margin_bottom(12);
+        content.append(sort_box);
+        content.append(top_processes_label);
+
+        top_processes_expander = new Gtk.Expander(_("Top Processes"));
+        top_processes_expander.set_child(content);
+        top_processes_expander.notify["expanded"].connect(() => {
+            if (top_processes_expander.get_expanded()) {
+                refresh_top_processes();
+            } else if (!top_processes_busy) {
+                // Close the cached per-pid descriptors while nothing is shown;
+                // a scan in flight does this itself once it finishes
+                release_top_processes();
+            }
+        });
+
+        info_container.append(top_processes_expander);
+    }
+
+    // Walking /proc takes a while on hosts with many processes, so the scan
+    // runs on a worker thread and only the label update goes back to the UI
+    private void refresh_top_processes() {
+        if (top_processes_busy) return;
+        top_processes_busy = true;
+
+        bool by_cpu = top_processes_by_cpu;
+        new Thread<void*>("ats-top-processes", () => {
+            string? report = get_top_processes_info(TOP_PROCESSES, by_cpu);
+            Idle.add(() => {
+                top_processes_busy = false;
+
+                if (!top_processes_expander.get_expanded()) {
+                    release_top_processes();
+                    return Source.REMOVE;
+                }
+
+                if (report != null) {
+                    top_processes_label.set_label(report);
+                } else {
+                    // CPU usage needs a second sample before it can be ranked
+                    top_processes_label.set_label(_("Sampling…"));
+                    Timeout.add_seconds(1, () => {
+                        if (top_processes_expander.get_expanded()) {
+                            refresh_top_processes();
+                        }
+                        return Source.REMOVE;
+                    });
+                }
+
+                // The sort order changed while scanning
+                if (by_cpu != top_processes_by_cpu) {
+                    refresh_top_processes();
+                }
+                return Source.REMOVE;
+            });
+            return null;
+        });
+    }
+
+    private Gtk.Label create_info_row(string label, string value) {
         var row_box = new Gtk.Box(Gtk.Orientation.HORIZONTAL, 12);
         row_box.set_margin_top(12);
         row_box.set_margin_bottom(12);
@@ -288,6 +416,7 @@ public class ATSApplication : Adw.Application {
         row_box.append(value_widget);
 
         info_container.append(row_box);
+        return value_widget;
     }
 
     private void add_separator() {
@@ -320,6 +449,9 @@ public class ATSApplication : Adw.Application {
             forced_distro = distro_opt.strip().down();
         }
 
+        // Lets the top processes view keep its per-pid descriptors open
+        raise_fd_limit();
+
         var app = new ATSApplication();
         return app.run(args);
     }